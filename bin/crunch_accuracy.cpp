@@ -0,0 +1,194 @@
+#include "mockup/cpu_cruncher.h"
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frequency scaling state read from cpufreq, empty fields when it isn't available.
+struct CpuFrequency {
+  std::string governor;      // distinct governors of all CPUs separated by ';'
+  std::string frequency_khz; // current frequency averaged over all CPUs
+};
+
+struct AccuracyStats {
+  CpuFrequency cpu_frequency;
+  unsigned int threads;
+  double       requested_us;
+  double       mean_us;
+  double       mean_rel_error;
+  double       stddev_rel_error;
+  double       p50_abs_rel_error;
+  double       p95_abs_rel_error;
+};
+
+boost::program_options::variables_map parse_arguments( int argc, char** argv ) {
+  auto desc = boost::program_options::options_description( "Options" );
+  desc.add_options()( "help,h", "Print help message." )(
+      "threads,t",
+      boost::program_options::value<std::vector<unsigned int>>()->multitoken()->default_value(
+          { 1, std::thread::hardware_concurrency() }, "1 hardware_concurrency" ),
+      "Numbers of threads crunching concurrently." )(
+      "durations", boost::program_options::value<std::vector<double>>()->multitoken()->default_value(
+                       { 1, 2, 5, 10, 20, 50, 100, 1000, 10000 }, "1 2 5 10 20 50 100 1000 10000" ),
+      "Requested durations in microseconds." )(
+      "samples", boost::program_options::value<unsigned int>()->default_value( 1000 ),
+      "Number of crunches per duration and thread." )(
+      "precise", boost::program_options::bool_switch(), "Use precise CPUCrunching." )(
+      "fast-calibrate", boost::program_options::bool_switch(), "Calibrate CPUCrunching on smaller sample." )(
+      "save-stats", boost::program_options::value<std::string>(), "Save the accuracy statistics to a CSV file." );
+
+  auto vm = boost::program_options::variables_map{};
+
+  try {
+    boost::program_options::store( boost::program_options::command_line_parser( argc, argv ).options( desc ).run(),
+                                   vm );
+    if ( vm.count( "help" ) ) {
+      std::cout << desc << std::endl;
+      std::exit( 0 );
+    }
+
+    boost::program_options::notify( vm );
+  } catch ( const boost::program_options::error& ex ) {
+    std::cerr << ex.what() << "\n\n"
+              << "Try '--help' for more information" << std::endl;
+    std::exit( 1 );
+  }
+  const auto& threads   = vm["threads"].as<std::vector<unsigned int>>();
+  const auto& durations = vm["durations"].as<std::vector<double>>();
+  if ( vm["samples"].as<unsigned int>() == 0 || std::find( threads.begin(), threads.end(), 0u ) != threads.end() ||
+       std::any_of( durations.begin(), durations.end(), []( double d ) { return !( d > 0 ); } ) ) {
+    std::cerr << "Samples and threads must be positive, durations greater than zero\n\n"
+              << "Try '--help' for more information" << std::endl;
+    std::exit( 1 );
+  }
+  return vm;
+}
+
+CpuFrequency read_cpu_frequency() {
+  auto governors = std::set<std::string>{};
+  auto total_khz = 0.;
+  auto cpus      = 0u;
+  for ( auto cpu = 0u;; ++cpu ) {
+    const auto cpufreq        = "/sys/devices/system/cpu/cpu" + std::to_string( cpu ) + "/cpufreq/";
+    auto       governor_file  = std::ifstream( cpufreq + "scaling_governor" );
+    auto       frequency_file = std::ifstream( cpufreq + "scaling_cur_freq" );
+    if ( !governor_file && !frequency_file ) { break; }
+    if ( auto governor = std::string{}; governor_file >> governor ) { governors.insert( governor ); }
+    if ( auto khz = 0.; frequency_file >> khz ) {
+      total_khz += khz;
+      ++cpus;
+    }
+  }
+  auto frequency = CpuFrequency{};
+  for ( const auto& governor : governors ) {
+    frequency.governor += ( frequency.governor.empty() ? "" : ";" ) + governor;
+  }
+  if ( cpus > 0 ) {
+    auto khz = std::ostringstream{};
+    khz << std::fixed << std::setprecision( 0 ) << total_khz / cpus;
+    frequency.frequency_khz = khz.str();
+  }
+  return frequency;
+}
+
+// Returns the relative errors (actual - requested) / requested of every crunch, grouped by duration. The frequency
+// scaling state is read while the threads are crunching.
+std::vector<std::vector<double>> measure( mockup::CPUCruncherBuilder& builder, unsigned int threads,
+                                          const std::vector<double>& durations_us, unsigned int samples,
+                                          CpuFrequency& cpu_frequency ) {
+  auto errors  = std::vector<std::vector<double>>( durations_us.size() );
+  auto results = std::vector<std::vector<std::vector<double>>>( threads );
+  auto workers = std::vector<std::thread>{};
+  for ( unsigned int t = 0; t < threads; ++t ) {
+    workers.emplace_back( [&durations_us, samples, &result = results[t], cruncher = builder.make()]() mutable {
+      result.resize( durations_us.size() );
+      for ( std::size_t d = 0; d < durations_us.size(); ++d ) {
+        const auto requested = std::chrono::duration<double, std::micro>( durations_us[d] );
+        cruncher.average( requested ).stddev( mockup::runtime_duration( 0 ) );
+        result[d].reserve( samples );
+        for ( unsigned int i = 0; i < samples; ++i ) {
+          auto start = std::chrono::steady_clock::now();
+          cruncher();
+          auto stop = std::chrono::steady_clock::now();
+          result[d].push_back( ( stop - start - requested ) / requested );
+        }
+      }
+    } );
+  }
+  cpu_frequency = read_cpu_frequency();
+  for ( auto& worker : workers ) { worker.join(); }
+  for ( const auto& result : results ) {
+    for ( std::size_t d = 0; d < durations_us.size(); ++d ) {
+      errors[d].insert( errors[d].end(), result[d].begin(), result[d].end() );
+    }
+  }
+  return errors;
+}
+
+AccuracyStats summarize( const CpuFrequency& cpu_frequency, unsigned int threads, double requested_us,
+                         std::vector<double> errors ) {
+  const auto n    = static_cast<double>( errors.size() );
+  const auto mean = std::accumulate( errors.begin(), errors.end(), 0. ) / n;
+  const auto var =
+      std::accumulate( errors.begin(), errors.end(), 0., [mean]( double acc, double e ) {
+        return acc + ( e - mean ) * ( e - mean );
+      } ) / n;
+  for ( auto& e : errors ) { e = std::abs( e ); }
+  std::sort( errors.begin(), errors.end() );
+  auto quantile = [&errors]( double q ) { return errors[static_cast<std::size_t>( q * ( errors.size() - 1 ) )]; };
+  return { cpu_frequency, threads, requested_us, requested_us * ( 1 + mean ), mean, std::sqrt( var ), quantile( .5 ),
+           quantile( .95 ) };
+}
+
+int main( int argc, char** argv ) {
+  const auto vm           = parse_arguments( argc, argv );
+  const auto thread_seq   = vm["threads"].as<std::vector<unsigned int>>();
+  const auto durations_us = vm["durations"].as<std::vector<double>>();
+  const auto samples      = vm["samples"].as<unsigned int>();
+  const auto precise      = vm["precise"].as<bool>();
+
+  auto builder = mockup::CPUCruncherBuilder{};
+  std::cout << "Calibrating CPUCrunching" << std::endl;
+  builder.calibrate( 1, mockup::runtime_duration( 0 ), 1, vm["fast-calibrate"].as<bool>(), precise );
+  std::cout << "Calibrating CPUCrunching done" << std::endl;
+
+  auto stats = std::vector<AccuracyStats>{};
+  std::cout << std::setw( 8 ) << "threads" << std::setw( 14 ) << "requested_us" << std::setw( 14 ) << "mean_us"
+            << std::setw( 14 ) << "mean_err" << std::setw( 14 ) << "stddev_err" << std::setw( 14 ) << "p50_abs_err"
+            << std::setw( 14 ) << "p95_abs_err" << std::endl;
+  for ( auto threads : thread_seq ) {
+    auto cpu_frequency = CpuFrequency{};
+    auto errors        = measure( builder, threads, durations_us, samples, cpu_frequency );
+    for ( std::size_t d = 0; d < durations_us.size(); ++d ) {
+      const auto& s =
+          stats.emplace_back( summarize( cpu_frequency, threads, durations_us[d], std::move( errors[d] ) ) );
+      std::cout << std::setw( 8 ) << s.threads << std::setw( 14 ) << s.requested_us << std::setw( 14 ) << s.mean_us
+                << std::setw( 14 ) << s.mean_rel_error << std::setw( 14 ) << s.stddev_rel_error << std::setw( 14 )
+                << s.p50_abs_rel_error << std::setw( 14 ) << s.p95_abs_rel_error << std::endl;
+    }
+  }
+
+  if ( vm.count( "save-stats" ) ) {
+    auto stats_file_name = vm["save-stats"].as<std::string>();
+    auto stats_file      = std::ofstream{ stats_file_name };
+    stats_file << "threads,requested_us,mean_us,mean_rel_error,stddev_rel_error,p50_abs_rel_error,p95_abs_rel_error,"
+                  "precise,governor,frequency_khz"
+               << std::endl;
+    for ( const auto& s : stats ) {
+      stats_file << s.threads << "," << s.requested_us << "," << s.mean_us << "," << s.mean_rel_error << ","
+                 << s.stddev_rel_error << "," << s.p50_abs_rel_error << "," << s.p95_abs_rel_error << "," << precise
+                 << "," << s.cpu_frequency.governor << "," << s.cpu_frequency.frequency_khz << std::endl;
+    }
+    std::cout << "Accuracy statistics saved to file: \"" << stats_file_name << '\"' << std::endl;
+  }
+  return 0;
+}
@@ -1,8 +1,13 @@
 #include "mockup/cpu_cruncher.h"
+#include "mockup/event_source.h"
 #include "mockup/graph_representation.h"
 #include "mockup/read_graph.h"
+#include "mockup/runtime_metrics.h"
+#include "mockup/slot_tuner.h"
+#include "mockup/trace_writer.h"
 #include "taskflow/algorithm/pipeline.hpp"
 #include "taskflow/core/taskflow.hpp"
+#include <algorithm>
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
@@ -13,8 +18,11 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 auto make_dummy_task( const mockup::df::VertexProperties& properties ) {
   return [name = properties.name]() { std::cout << name << std::endl; };
@@ -57,6 +65,139 @@ tf::Taskflow make_flow( mockup::CPUCruncherBuilder& task_builder, const mockup::
   return flow;
 };
 
+// Streams fixed-size task records through `mockup::TraceWriter` instead of keeping them in memory until the end of
+// the run. Each worker keeps a stack of entry times to handle tasks nested by `corun`.
+class StreamingTraceObserver : public tf::ObserverInterface {
+public:
+  StreamingTraceObserver( std::string filename, std::size_t buffer_records )
+      : m_filename( std::move( filename ) ), m_buffer_records( buffer_records ) {}
+
+  void set_up( std::size_t num_workers ) override final {
+    m_writer  = std::make_unique<mockup::TraceWriter>( m_filename, num_workers, m_buffer_records );
+    m_workers = std::vector<WorkerState>( num_workers );
+  }
+
+  void on_entry( tf::WorkerView wv, tf::TaskView ) override final {
+    m_workers[wv.id()].begins.push_back( m_writer->now() );
+  }
+
+  void on_exit( tf::WorkerView wv, tf::TaskView tv ) override final {
+    const auto end    = m_writer->now();
+    auto&      worker = m_workers[wv.id()];
+
+    auto [it, inserted] = worker.name_ids.try_emplace( tv.hash_value(), 0 );
+    if ( inserted ) { it->second = m_writer->name_id( tv.name() ); }
+    m_writer->record( wv.id(), it->second, worker.begins.back(), end );
+    worker.begins.pop_back();
+  }
+
+  // Returns the number of records dropped because the disk couldn't keep up.
+  std::uint64_t close() {
+    m_writer->close();
+    return m_writer->dropped();
+  }
+
+private:
+  struct alignas( 64 ) WorkerState {
+    std::vector<std::uint64_t>                     begins;
+    std::unordered_map<std::size_t, std::uint32_t> name_ids;
+  };
+
+  std::string                          m_filename;
+  std::size_t                          m_buffer_records;
+  std::unique_ptr<mockup::TraceWriter> m_writer;
+  std::vector<WorkerState>             m_workers;
+};
+
+// Publishes the algorithm each worker is running and the worker queue sizes to `mockup::RuntimeMetrics`. Queue sizes
+// are refreshed on both entry and exit, so that a worker whose tasks were stolen doesn't keep reporting them.
+class MetricsObserver : public tf::ObserverInterface {
+public:
+  MetricsObserver( mockup::RuntimeMetrics& metrics, std::unordered_set<std::size_t> algorithms )
+      : m_metrics( metrics ), m_algorithms( std::move( algorithms ) ) {}
+
+  void set_up( std::size_t ) override final {}
+
+  void on_entry( tf::WorkerView wv, tf::TaskView tv ) override final {
+    m_metrics.queue_size( wv.id(), wv.queue_size() );
+    if ( m_algorithms.count( tv.hash_value() ) ) { m_metrics.task_entry( wv.id(), tv.name() ); }
+  }
+
+  void on_exit( tf::WorkerView wv, tf::TaskView tv ) override final {
+    m_metrics.queue_size( wv.id(), wv.queue_size() );
+    if ( m_algorithms.count( tv.hash_value() ) ) { m_metrics.task_exit( wv.id() ); }
+  }
+
+private:
+  mockup::RuntimeMetrics&               m_metrics;
+  const std::unordered_set<std::size_t> m_algorithms;
+};
+
+[[noreturn]] void option_error( const std::exception& ex ) {
+  std::cerr << ex.what() << "\n\n"
+            << "Try '--help' for more information" << std::endl;
+  std::exit( 1 );
+}
+
+std::vector<std::size_t> input_event_sizes( const boost::program_options::variables_map& vm ) {
+  try {
+    return vm.count( "input-sizes" ) ? mockup::read_event_sizes( vm["input-sizes"].as<std::string>() )
+                                     : std::vector<std::size_t>{ vm["input-event-size"].as<std::size_t>() };
+  } catch ( const std::exception& ex ) { option_error( ex ); }
+}
+
+std::unique_ptr<mockup::EventSource> make_event_source( const boost::program_options::variables_map& vm,
+                                                       unsigned int                                 slots ) {
+  if ( !vm.count( "input" ) ) { return nullptr; }
+  const auto mode_name = vm["input-mode"].as<std::string>();
+  if ( mode_name != "mmap" && mode_name != "read" ) {
+    std::cerr << "Unknown input mode: " << mode_name << "\n\n"
+              << "Try '--help' for more information" << std::endl;
+    std::exit( 1 );
+  }
+  auto sizes    = input_event_sizes( vm );
+  auto prefetch = vm.count( "input-prefetch" ) ? vm["input-prefetch"].as<unsigned int>() : slots;
+  auto mode     = mode_name == "mmap" ? mockup::EventSource::Mode::Mmap : mockup::EventSource::Mode::Read;
+  try {
+    return std::make_unique<mockup::EventSource>( vm["input"].as<std::string>(), std::move( sizes ), prefetch, mode );
+  } catch ( const std::exception& ex ) { option_error( ex ); }
+}
+
+// Number of event slots to allocate. When tuning, the slots are bounded by --max-slots and by the --memory-cap
+// divided by the estimated per-event memory, i.e. the data objects of the workflow and the input payload. Without
+// any estimate the cap is rejected, with data objects lacking sizes it only accounts for the input payload.
+unsigned int allocated_slots( const boost::program_options::variables_map& vm, const mockup::df::Graph& dag ) {
+  const auto slots = vm["slots"].as<unsigned int>();
+  if ( !vm["auto-slots"].as<bool>() ) { return slots; }
+  auto max_slots = vm.count( "max-slots" ) ? vm["max-slots"].as<unsigned int>()
+                                           : std::max( slots, vm["threads"].as<unsigned int>() );
+  if ( vm.count( "memory-cap" ) ) {
+    auto data_memory_B = 0.;
+    for ( auto node_id : boost::make_iterator_range( boost::vertices( dag ) ) ) {
+      if ( dag[node_id].type == mockup::DataObjectKey ) { data_memory_B += dag[node_id].memory_footprint_B; }
+    }
+    auto event_memory_B = data_memory_B;
+    if ( vm.count( "input" ) ) {
+      const auto sizes = input_event_sizes( vm );
+      event_memory_B += *std::max_element( sizes.begin(), sizes.end() );
+    }
+    if ( event_memory_B <= 0 ) {
+      std::cerr << "--memory-cap needs a per-event memory estimate, but the data objects have no size_average_B "
+                   "and no --input is given\n\n"
+                << "Try '--help' for more information" << std::endl;
+      std::exit( 1 );
+    }
+    if ( data_memory_B <= 0 ) {
+      std::cerr << "Warning: the data objects have no size_average_B, --memory-cap only accounts for the input "
+                   "payload"
+                << std::endl;
+    }
+    const auto capped = vm["memory-cap"].as<double>() * 1e6 / event_memory_B;
+    max_slots         = static_cast<unsigned int>( std::min<double>( max_slots, std::max( capped, 1. ) ) );
+  }
+  return std::max( max_slots, 1u );
+}
+
 boost::program_options::variables_map parse_arguments( int argc, char** argv ) {
   auto desc = boost::program_options::options_description( "General" );
   desc.add_options()( "help,h", "Print help message." )(
@@ -72,19 +213,50 @@ boost::program_options::variables_map parse_arguments( int argc, char** argv ) {
       "threads,t", boost::program_options::value<unsigned int>()->default_value( std::thread::hardware_concurrency() ),
       "Number of threads to use." )( "event-count", boost::program_options::value<unsigned int>()->default_value( 1 ),
                                      "Number of events to be processed." )(
-      "slots", boost::program_options::value<unsigned int>()->default_value( 1 ), "Number of concurrent event slots." );
+      "slots", boost::program_options::value<unsigned int>()->default_value( 1 ), "Number of concurrent event slots." )(
+      "auto-slots", boost::program_options::bool_switch(),
+      "Tune the number of concurrent events at runtime, starting from --slots." )(
+      "max-slots", boost::program_options::value<unsigned int>(),
+      "Upper bound of concurrent events when tuning. Defaults to the larger of --slots and --threads." )(
+      "memory-cap", boost::program_options::value<double>(),
+      "Memory cap in MB for the estimated per-event memory of concurrent events when tuning." )(
+      "tune-period", boost::program_options::value<unsigned int>()->default_value( 10000 ),
+      "Period in milliseconds over which throughput is measured between tuning steps. It should cover several event "
+      "completions." );
+
+  auto desc_input = boost::program_options::options_description( "Input" );
+  desc_input.add_options()( "input", boost::program_options::value<std::string>(),
+                            "Stream per-event input payloads from this file in the source stage." )(
+      "input-event-size", boost::program_options::value<std::size_t>()->default_value( 1 << 20 ),
+      "Size of each event input payload in bytes." )(
+      "input-sizes", boost::program_options::value<std::string>(),
+      "File with recorded per-event input sizes in bytes, used cyclically instead of --input-event-size." )(
+      "input-prefetch", boost::program_options::value<unsigned int>(),
+      "Number of event payloads read ahead. Defaults to the number of allocated slots." )(
+      "input-mode", boost::program_options::value<std::string>()->default_value( "mmap" ),
+      "Input access mode: mmap or read." );
 
   auto desc_trace = boost::program_options::options_description( "Logging and trace" );
   desc_trace.add_options()( "trace-tfp", boost::program_options::value<std::string>(),
                             "Output the execution logs as a TFProf trace. Must be a json or tfp file." )(
       "trace-chrome", boost::program_options::value<std::string>(),
       "Output the execution logs as a chrome trace. Must be a json file." )(
+      "trace-stream", boost::program_options::value<std::string>(),
+      "Stream the execution logs to a binary trace file. Convert with trace_convert." )(
+      "trace-buffer", boost::program_options::value<std::size_t>()->default_value( 1 << 14 ),
+      "Number of records buffered per thread before handing them to the trace writer." )(
+      "metrics", boost::program_options::value<std::string>(),
+      "Periodically export runtime metrics as Prometheus text to a file or to unix:<path> socket." )(
+      "metrics-period", boost::program_options::value<unsigned int>()->default_value( 1000 ),
+      "Metrics sampling period in milliseconds." )(
       "dump-plan", boost::program_options::bool_switch(), "Write execution plan to files named {name}.dot." )(
       "fast-calibrate", boost::program_options::bool_switch(), "Calibrate CPUCrunching on smaller sample." )(
+      "precise-crunch", boost::program_options::bool_switch(),
+      "Refine CPUCrunching calibration for microsecond-scale algorithms and spin until the requested duration." )(
       "disable-logging", boost::program_options::bool_switch(), "Disable printing logging information." );
 
   boost::program_options::options_description cmdline_options{ "Options" };
-  cmdline_options.add( desc ).add( desc_runtime ).add( desc_trace );
+  cmdline_options.add( desc ).add( desc_runtime ).add( desc_input ).add( desc_trace );
 
   auto vm = boost::program_options::variables_map{};
 
@@ -114,40 +286,82 @@ int main( int argc, char** argv ) {
   const auto vm = parse_arguments( argc, argv );
   enable_logging( !vm["disable-logging"].as<bool>() );
   const auto fast_calibrate = vm["fast-calibrate"].as<bool>();
+  const auto precise_crunch = vm["precise-crunch"].as<bool>();
   const auto slots          = vm["slots"].as<unsigned int>();
+  const auto auto_slots     = vm["auto-slots"].as<bool>();
   const auto threads        = vm["threads"].as<unsigned int>();
   const auto max_events     = vm["event-count"].as<unsigned int>();
   const auto workload_name  = vm["name"].as<std::string>();
   const auto dag            = mockup::read_df( vm["dfg"].as<std::string>() );
+  const auto lines          = allocated_slots( vm, dag );
 
   auto executor        = tf::Executor{ threads };
   auto chrome_observer = vm.count( "trace-chrome" ) ? executor.make_observer<tf::ChromeObserver>() : nullptr;
   auto tfp_observer    = vm.count( "trace-tfp" ) ? executor.make_observer<tf::TFProfObserver>() : nullptr;
+  auto stream_observer = vm.count( "trace-stream" )
+                             ? executor.make_observer<StreamingTraceObserver>( vm["trace-stream"].as<std::string>(),
+                                                                               vm["trace-buffer"].as<std::size_t>() )
+                             : nullptr;
 
   auto task_builder = mockup::CPUCruncherBuilder{};
   std::cout << "Calibrating CPUCrunching" << std::endl;
-  task_builder.calibrate( 1, mockup::runtime_duration( 0 ), 1, fast_calibrate );
+  task_builder.calibrate( 1, mockup::runtime_duration( 0 ), 1, fast_calibrate, precise_crunch );
   std::cout << "Calibrating CPUCrunching done" << std::endl;
   auto core_flows = std::vector<tf::Taskflow>{};
-  core_flows.reserve( slots );
-  for ( int i = 0; i < slots; ++i ) {
+  core_flows.reserve( lines );
+  for ( int i = 0; i < lines; ++i ) {
     core_flows.emplace_back( make_flow( task_builder, dag ) );
     core_flows[i].name( workload_name + "-core-" + std::to_string( i ) );
   }
+
+  auto metrics =
+      vm.count( "metrics" ) || auto_slots ? std::make_unique<mockup::RuntimeMetrics>( threads ) : nullptr;
+  if ( metrics ) {
+    auto algorithms = std::unordered_set<std::size_t>{};
+    for ( auto& flow : core_flows ) {
+      flow.for_each_task( [&algorithms]( tf::Task task ) { algorithms.insert( task.hash_value() ); } );
+    }
+    executor.make_observer<MetricsObserver>( *metrics, std::move( algorithms ) );
+  }
+
+  auto event_source  = make_event_source( vm, lines );
+  auto event_buffers = std::vector<mockup::EventBuffer>( lines );
+  auto slot_tuner    = auto_slots ? std::make_unique<mockup::SlotTuner>( slots, lines ) : nullptr;
+
   auto pipeline = tf::Pipeline{
-      slots,
+      lines,
       tf::Pipe{ tf::PipeType::SERIAL,
-                [max_events]( tf::Pipeflow& pf ) {
+                [max_events, &executor, metrics = metrics.get(), tuner = slot_tuner.get(), source = event_source.get(),
+                 &event_buffers]( tf::Pipeflow& pf ) {
                   if ( pf.token() >= max_events ) {
+                    if ( metrics ) { metrics->source_stopped(); }
                     pf.stop();
                   } else {
+                    if ( metrics && pf.token() == 0 ) { metrics->source_started(); }
+                    if ( tuner ) {
+                      // keep the worker busy with other tasks until the number of events in flight drops below target
+                      executor.corun_until(
+                          [metrics, tuner]() { return metrics->slots_in_flight() < tuner->target(); } );
+                    }
+                    if ( source ) { event_buffers[pf.line()] = source->acquire(); }
+                    if ( metrics ) { metrics->event_started(); }
                     BOOST_LOG_TRIVIAL( info ) << "Begin event: " << pf.token();
                   }
                 } },
       tf::Pipe{ tf::PipeType::PARALLEL,
-                [&executor, &core_flows]( tf::Pipeflow& pf ) { executor.corun( core_flows[pf.line()] ); } },
+                [&executor, &core_flows, source = event_source.get(), &event_buffers]( tf::Pipeflow& pf ) {
+                  if ( source ) {
+                    // volatile so that the payload reads aren't optimized away
+                    [[maybe_unused]] volatile auto checksum = mockup::consume_payload( event_buffers[pf.line()] );
+                  }
+                  executor.corun( core_flows[pf.line()] );
+                } },
       tf::Pipe{ tf::PipeType::PARALLEL,
-                []( tf::Pipeflow& pf ) { BOOST_LOG_TRIVIAL( info ) << "End event: " << pf.token(); } } };
+                [metrics = metrics.get(), source = event_source.get(), &event_buffers]( tf::Pipeflow& pf ) {
+                  if ( source ) { source->release( event_buffers[pf.line()] ); }
+                  if ( metrics ) { metrics->event_completed(); }
+                  BOOST_LOG_TRIVIAL( info ) << "End event: " << pf.token();
+                } } };
 
   auto master_flow = tf::Taskflow{ workload_name };
 
@@ -160,24 +374,71 @@ int main( int argc, char** argv ) {
   core_task.precede( final_task );
 
   if ( !vm["dry-run"].as<bool>() ) {
+    // Elapsed time, slots and how the slots were chosen: "fixed" by --slots, "auto" while tuning up to the allocated
+    // slots, or "pinned" to a count after tuning.
+    struct Timing {
+      double       seconds;
+      unsigned int max_concurrent;
+      std::string  slots_mode;
+    };
     const auto trials  = vm["trials"].as<unsigned int>();
-    auto       timings = std::vector<double>( trials );
-    for ( auto i = 0; i < trials; ++i ) {
+    auto       timings = std::vector<Timing>{};
+
+    auto metrics_exporter = std::unique_ptr<mockup::MetricsExporter>{};
+    if ( vm.count( "metrics" ) ) {
+      try {
+        metrics_exporter = std::make_unique<mockup::MetricsExporter>(
+            *metrics, vm["metrics"].as<std::string>(),
+            std::chrono::milliseconds( vm["metrics-period"].as<unsigned int>() ) );
+      } catch ( const std::exception& ex ) { option_error( ex ); }
+    }
+    auto slot_controller =
+        slot_tuner ? std::make_unique<mockup::SlotController>(
+                         *metrics, *slot_tuner, std::chrono::milliseconds( vm["tune-period"].as<unsigned int>() ) )
+                   : nullptr;
+    auto run_trial = [&executor, &master_flow, &pipeline]() {
       auto start_time = std::chrono::high_resolution_clock::now();
       executor.run( master_flow ).wait();
-      auto end_time        = std::chrono::high_resolution_clock::now();
-      auto elapsed_seconds = std::chrono::duration<double>( end_time - start_time ).count();
+      auto end_time = std::chrono::high_resolution_clock::now();
       pipeline.reset();
+      return std::chrono::duration<double>( end_time - start_time ).count();
+    };
+    for ( auto i = 0; i < trials; ++i ) {
+      auto elapsed_seconds = run_trial();
       std::cout << "Execution time: " << elapsed_seconds << " s (Throughput: " << max_events / elapsed_seconds
                 << " evt/s)" << std::endl;
-      timings[i] = elapsed_seconds;
+      timings.push_back( { elapsed_seconds, slot_tuner ? lines : slots, slot_tuner ? "auto" : "fixed" } );
+    }
+    if ( slot_controller ) {
+      slot_controller->stop();
+      // compare whole runs with the slots pinned, so that neither side pays for the exploration
+      const auto converged = slot_tuner->converged();
+      slot_tuner->set_target( converged );
+      const auto tuned_seconds = run_trial();
+      slot_tuner->set_target( slots );
+      const auto fixed_slots   = slot_tuner->target();
+      const auto fixed_seconds = converged == fixed_slots ? tuned_seconds : run_trial();
+      timings.push_back( { tuned_seconds, converged, "pinned" } );
+      if ( converged != fixed_slots ) { timings.push_back( { fixed_seconds, fixed_slots, "pinned" } ); }
+      std::cout << "Auto-tuned slots: " << converged << " (Throughput: " << max_events / tuned_seconds
+                << " evt/s, fixed " << fixed_slots << " slots: " << max_events / fixed_seconds << " evt/s)"
+                << std::endl;
+    }
+    if ( metrics_exporter ) {
+      metrics_exporter->stop();
+      if ( const auto error = metrics_exporter->error(); !error.empty() ) {
+        std::cerr << "Runtime metrics export failed: " << error << std::endl;
+      } else {
+        std::cout << "Runtime metrics exported to: \"" << vm["metrics"].as<std::string>() << '\"' << std::endl;
+      }
     }
     if ( vm.count( "save-timing" ) ) {
       auto timing_file_name = vm["save-timing"].as<std::string>();
       auto timing_file      = std::ofstream{ timing_file_name };
-      timing_file << "time,throughput,threads,event_count,max_concurrent" << std::endl;
+      timing_file << "time,throughput,threads,event_count,max_concurrent,slots_mode" << std::endl;
       for ( const auto& t : timings ) {
-        timing_file << t << "," << max_events / t << "," << threads << "," << max_events << "," << slots << std::endl;
+        timing_file << t.seconds << "," << max_events / t.seconds << "," << threads << "," << max_events << ","
+                    << t.max_concurrent << "," << t.slots_mode << std::endl;
       }
       std::cout << "Timing results saved to file: \"" << timing_file_name << '\"' << std::endl;
     }
@@ -194,6 +455,12 @@ int main( int argc, char** argv ) {
       tfp_observer->dump( traceFile );
       std::cout << "TFProf trace written to file: \"" << trace_file_name << '\"' << std::endl;
     }
+    if ( stream_observer ) {
+      if ( const auto dropped = stream_observer->close(); dropped > 0 ) {
+        std::cerr << "Binary trace dropped " << dropped << " records, increase --trace-buffer" << std::endl;
+      }
+      std::cout << "Binary trace written to file: \"" << vm["trace-stream"].as<std::string>() << '\"' << std::endl;
+    }
   }
   if ( vm["dump-plan"].as<bool>() ) {
     auto plan_file_name = workload_name + ".dot";
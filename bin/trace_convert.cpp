@@ -0,0 +1,64 @@
+#include "mockup/trace_writer.h"
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+boost::program_options::variables_map parse_arguments( int argc, char** argv ) {
+  auto desc = boost::program_options::options_description( "General" );
+  desc.add_options()( "help,h", "Print help message." )(
+      "input", boost::program_options::value<std::string>()->required(),
+      "Binary trace file written with --trace-stream." )(
+      "output", boost::program_options::value<std::string>()->required(), "Output chrome trace. Must be a json file." );
+
+  auto positional = boost::program_options::positional_options_description{};
+  positional.add( "input", 1 ).add( "output", 1 );
+
+  auto vm = boost::program_options::variables_map{};
+
+  try {
+    boost::program_options::store(
+        boost::program_options::command_line_parser( argc, argv ).options( desc ).positional( positional ).run(), vm );
+    if ( vm.count( "help" ) ) {
+      std::cout << desc << std::endl;
+      std::exit( 0 );
+    }
+
+    boost::program_options::notify( vm );
+  } catch ( const boost::program_options::error& ex ) {
+    std::cerr << ex.what() << "\n\n"
+              << "Try '--help' for more information" << std::endl;
+    std::exit( 1 );
+  }
+  return vm;
+}
+
+int main( int argc, char** argv ) {
+  const auto vm               = parse_arguments( argc, argv );
+  const auto input_file_name  = vm["input"].as<std::string>();
+  const auto output_file_name = vm["output"].as<std::string>();
+
+  auto input = std::ifstream( input_file_name, std::ios::binary );
+  if ( !input ) {
+    std::cerr << "Can't open trace file: \"" << input_file_name << '\"' << std::endl;
+    return 1;
+  }
+  auto output = std::ofstream( output_file_name );
+  if ( !output ) {
+    std::cerr << "Can't open output file: \"" << output_file_name << '\"' << std::endl;
+    return 1;
+  }
+  try {
+    mockup::convert_trace_to_chrome( input, output );
+  } catch ( const std::runtime_error& ex ) {
+    std::cerr << ex.what() << std::endl;
+    return 1;
+  }
+  output.close();
+  if ( !output ) {
+    std::cerr << "Can't write output file: \"" << output_file_name << '\"' << std::endl;
+    return 1;
+  }
+  std::cout << "Perfetto trace written to file: \"" << output_file_name << '\"' << std::endl;
+  return 0;
+}
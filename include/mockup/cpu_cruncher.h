@@ -12,14 +12,19 @@ namespace mockup {
 
     class CPUCruncher {
     public:
-      void calibrate( double correction_factor, runtime_duration min_time, unsigned int min_runs, bool fast_calibrate );
+      // In precise mode the calibration grid is refined for microsecond-scale durations and timed with sub-microsecond
+      // resolution. Durations below 100 us are crunched for 80% and then spin on a steady_clock deadline, so that they
+      // are never undershot. Longer durations and the default mode only crunch the interpolated iterations.
+      void calibrate( double correction_factor, runtime_duration min_time, unsigned int min_runs, bool fast_calibrate,
+                      bool precise = false );
       void crunch( runtime_duration duration ) const;
 
     private:
       unsigned int get_iterations( runtime_duration duration ) const;
 
-      std::vector<unsigned int> m_times_vect;
+      std::vector<double>       m_times_vect; // in microseconds
       std::vector<unsigned int> m_niters_vect;
+      bool                      m_precise = false;
     };
 
   } // namespace detail
@@ -50,8 +55,8 @@ namespace mockup {
   public:
     CPUCruncherBuilder() : m_cruncher( std::make_shared<detail::CPUCruncher>() ), m_random{} {}
     CPUCruncherBuilder& calibrate( double correction_factor = 1, runtime_duration min_time = runtime_duration( 0 ),
-                                   unsigned int min_runs = 1, bool fast_calibrate=false ) {
-      m_cruncher->calibrate( correction_factor, min_time, min_runs, fast_calibrate );
+                                   unsigned int min_runs = 1, bool fast_calibrate = false, bool precise = false ) {
+      m_cruncher->calibrate( correction_factor, min_time, min_runs, fast_calibrate, precise );
       return *this;
     }
     CPUCruncher make() {
@@ -0,0 +1,83 @@
+#ifndef TASKFLOW_FWK_EVENT_SOURCE_H_
+#define TASKFLOW_FWK_EVENT_SOURCE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace mockup {
+
+  // Input payload of a single event. The data is owned by the `EventSource` until the buffer is released.
+  struct EventBuffer {
+    const std::byte* data  = nullptr;
+    std::size_t      size  = 0;
+    std::size_t      index = 0; // buffer index used for recycling, unused when memory mapped
+  };
+
+  // Streams consecutive per-event payloads from a file, wrapping around at the end of the file. The event sizes are
+  // taken cyclically from `event_sizes`. At most `prefetch` events are read ahead of the consumer:
+  // - Mmap: payloads point directly into the mapped file, read-ahead is requested with madvise,
+  // - Read: a background thread reads payloads into a pool of recycled buffers.
+  class EventSource {
+  public:
+    enum class Mode { Mmap, Read };
+
+    EventSource( const std::string& filename, std::vector<std::size_t> event_sizes, std::size_t prefetch,
+                 Mode mode = Mode::Mmap );
+    ~EventSource();
+
+    EventSource( const EventSource& )            = delete;
+    EventSource& operator=( const EventSource& ) = delete;
+
+    // Blocks until the payload of the next event is available.
+    EventBuffer acquire();
+    // Hands the buffer of a processed event back for reuse.
+    void release( const EventBuffer& buffer );
+
+  private:
+    struct Cursor {
+      std::size_t event  = 0;
+      std::size_t offset = 0;
+    };
+
+    // Returns the {offset, size} of the event under the cursor and advances it.
+    std::pair<std::size_t, std::size_t> advance( Cursor& cursor ) const;
+    void                                advise( std::size_t offset, std::size_t size ) const;
+    void                                read_loop();
+
+    const std::vector<std::size_t> m_event_sizes;
+    const std::size_t              m_prefetch;
+    const Mode                     m_mode;
+    int                            m_fd        = -1;
+    std::size_t                    m_file_size = 0;
+    const std::byte*               m_mapping   = nullptr;
+    std::size_t                    m_max_size  = 0;
+    Cursor                         m_cursor;
+    Cursor                         m_ahead;
+
+    std::mutex                                m_mutex;
+    std::condition_variable                   m_ready_cv;
+    std::condition_variable                   m_space_cv;
+    std::deque<EventBuffer>                   m_ready;
+    std::vector<std::unique_ptr<std::byte[]>> m_buffers;
+    std::vector<std::size_t>                  m_free;
+    std::exception_ptr                        m_error;
+    bool                                      m_stop = false;
+    std::thread                               m_reader;
+  };
+
+  // Reads whitespace separated per-event sizes in bytes, e.g. recorded from a production job.
+  std::vector<std::size_t> read_event_sizes( const std::string& filename );
+
+  // Reads every cache line of the payload, emulating the deserialisation of the event input.
+  std::uint64_t consume_payload( const EventBuffer& buffer );
+
+} // namespace mockup
+#endif // TASKFLOW_FWK_EVENT_SOURCE_H_
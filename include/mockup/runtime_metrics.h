@@ -0,0 +1,129 @@
+#ifndef TASKFLOW_FWK_RUNTIME_METRICS_H_
+#define TASKFLOW_FWK_RUNTIME_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace mockup {
+
+  struct RunningTask {
+    std::size_t worker;
+    std::string name;
+    double      elapsed_s;
+  };
+
+  struct MetricsSample {
+    std::uint64_t            events_completed  = 0;
+    std::uint64_t            slots_in_flight   = 0;
+    double                   throughput        = 0; // events/s over the rolling window
+    std::uint64_t            ready_queue_depth = 0;
+    std::size_t              busy_workers      = 0;
+    std::size_t              idle_workers      = 0;
+    std::vector<RunningTask> longest_running;
+  };
+
+  // Counters updated from the hot path with relaxed atomics and read concurrently by a sampler.
+  // Per-worker state must only be updated by the worker owning it.
+  class RuntimeMetrics {
+  public:
+    explicit RuntimeMetrics( std::size_t num_workers );
+
+    void event_started() { m_events_started.fetch_add( 1, std::memory_order_relaxed ); }
+    void event_completed() { m_events_completed.fetch_add( 1, std::memory_order_relaxed ); }
+    // Brackets the period in which the event source issues new events, e.g. one run of the pipeline.
+    void source_started() {
+      m_source_runs.fetch_add( 1, std::memory_order_relaxed );
+      m_source_active.store( true, std::memory_order_relaxed );
+    }
+    void source_stopped() { m_source_active.store( false, std::memory_order_relaxed ); }
+    // `name` must outlive the task, e.g. reference the name stored in the task graph.
+    void task_entry( std::size_t worker, const std::string& name );
+    void task_exit( std::size_t worker );
+    // Size of the worker's own queue as last seen by the worker. Tasks in the executor's shared queue aren't counted.
+    void queue_size( std::size_t worker, std::size_t size ) {
+      m_workers[worker].queue_size.store( size, std::memory_order_relaxed );
+    }
+
+    std::size_t   num_workers() const { return m_num_workers; }
+    std::uint64_t events_completed() const { return m_events_completed.load( std::memory_order_relaxed ); }
+    std::uint64_t slots_in_flight() const;
+    bool          source_active() const { return m_source_active.load( std::memory_order_relaxed ); }
+    // Number of times the source was started, to tell runs apart.
+    std::uint64_t source_runs() const { return m_source_runs.load( std::memory_order_relaxed ); }
+    // Time spent in finished tasks summed over all workers.
+    double busy_seconds() const;
+    // Sample without the rolling throughput, which is left to the caller.
+    MetricsSample sample( std::size_t top ) const;
+
+  private:
+    struct alignas( 64 ) WorkerState {
+      std::atomic<const std::string*> task{ nullptr };
+      std::atomic<std::int64_t>       begin_ns{ 0 };
+      std::atomic<std::size_t>        queue_size{ 0 };
+      std::atomic<std::int64_t>       busy_ns{ 0 };
+    };
+
+    std::size_t                    m_num_workers;
+    std::unique_ptr<WorkerState[]> m_workers;
+    std::atomic<std::uint64_t>     m_events_started{ 0 };
+    std::atomic<std::uint64_t>     m_events_completed{ 0 };
+    std::atomic<std::uint64_t>     m_source_runs{ 0 };
+    std::atomic<bool>              m_source_active{ false };
+  };
+
+  void format_prometheus( const MetricsSample& sample, std::ostream& output );
+
+  // Background thread periodically sampling `RuntimeMetrics` and publishing them as Prometheus text.
+  // `target` is either a file path, replaced atomically on every sample, or `unix:<path>` to serve the
+  // latest sample to every client connecting to a Unix socket. An existing path is only replaced if it is a socket.
+  // Failing to set up the target throws, failing to publish a sample later is reported by `error()`.
+  class MetricsExporter {
+  public:
+    MetricsExporter( const RuntimeMetrics& metrics, std::string target,
+                     std::chrono::milliseconds period = std::chrono::milliseconds( 1000 ),
+                     std::chrono::milliseconds window = std::chrono::milliseconds( 10000 ), std::size_t top = 5 );
+    ~MetricsExporter();
+
+    MetricsExporter( const MetricsExporter& )            = delete;
+    MetricsExporter& operator=( const MetricsExporter& ) = delete;
+
+    // Stops the sampler thread. A file target receives a final sample, a socket target is closed without serving it.
+    void stop();
+    // Last publishing error, empty if every sample was published.
+    std::string error() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    void run();
+    void publish( const std::string& text );
+    void serve( const std::string& text, clock::time_point until );
+
+    const RuntimeMetrics&                                   m_metrics;
+    std::string                                             m_target;
+    const std::chrono::milliseconds                         m_period;
+    const std::chrono::milliseconds                         m_window;
+    const std::size_t                                       m_top;
+    int                                                     m_socket = -1;
+    std::pair<dev_t, ino_t>                                 m_socket_id; // identifies the bound socket file
+    std::deque<std::pair<clock::time_point, std::uint64_t>> m_history;
+
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cv;
+    bool                    m_stop = false;
+    std::string             m_error;
+    std::thread             m_sampler;
+  };
+
+} // namespace mockup
+#endif // TASKFLOW_FWK_RUNTIME_METRICS_H_
@@ -0,0 +1,71 @@
+#ifndef TASKFLOW_FWK_SLOT_TUNER_H_
+#define TASKFLOW_FWK_SLOT_TUNER_H_
+
+#include "mockup/runtime_metrics.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+namespace mockup {
+
+  // Hill climbing on the number of concurrently processed events. Every update feeds the throughput measured at the
+  // current target and moves the target towards higher throughput, halving the step whenever the direction reverses.
+  // On a plateau the target moves up while workers are idle and down otherwise, to save memory.
+  class SlotTuner {
+  public:
+    SlotTuner( unsigned int initial, unsigned int max_slots, double tolerance = 0.02, double idle_threshold = 0.05 );
+
+    unsigned int target() const { return m_target.load( std::memory_order_relaxed ); }
+    unsigned int max_slots() const { return m_max_slots; }
+    // Pins the target, e.g. to measure a fixed number of slots once tuning is over.
+    void set_target( unsigned int slots );
+    // Not thread-safe, meant to be called by a single controller.
+    unsigned int update( double throughput, double idle_fraction );
+    // Smallest slot count whose mean throughput is within tolerance of the best one measured.
+    unsigned int converged() const;
+    // Mean throughput measured at `slots`, zero if never measured.
+    double throughput( unsigned int slots ) const;
+
+  private:
+    std::atomic<unsigned int>                    m_target;
+    const unsigned int                           m_max_slots;
+    const double                                 m_tolerance;
+    const double                                 m_idle_threshold;
+    int                                          m_direction = 0;
+    unsigned int                                 m_step;
+    double                                       m_last_throughput = -1;
+    std::vector<std::pair<double, unsigned int>> m_measurements; // sum and count indexed by slots
+  };
+
+  // Background thread measuring throughput and worker idle time from `RuntimeMetrics` every period and feeding them
+  // to a `SlotTuner`. Only periods in which the source kept issuing events are measured, skipping the ramp-up of a
+  // run until its first event completes, the drain after the source stops and one settling period per target change.
+  class SlotController {
+  public:
+    SlotController( const RuntimeMetrics& metrics, SlotTuner& tuner,
+                    std::chrono::milliseconds period = std::chrono::milliseconds( 10000 ) );
+    ~SlotController();
+
+    SlotController( const SlotController& )            = delete;
+    SlotController& operator=( const SlotController& ) = delete;
+
+    void stop();
+
+  private:
+    void run();
+
+    const RuntimeMetrics&           m_metrics;
+    SlotTuner&                      m_tuner;
+    const std::chrono::milliseconds m_period;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_cv;
+    bool                    m_stop = false;
+    std::thread             m_controller;
+  };
+
+} // namespace mockup
+#endif // TASKFLOW_FWK_SLOT_TUNER_H_
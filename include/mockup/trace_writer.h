@@ -0,0 +1,103 @@
+#ifndef TASKFLOW_FWK_TRACE_WRITER_H_
+#define TASKFLOW_FWK_TRACE_WRITER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace mockup {
+
+  namespace trace {
+    // On-disk layout: `Magic` followed by a sequence of blocks. Each block starts with a `BlockHeader`
+    // and holds either `count` name entries ({uint32 id, uint32 length, chars}) or `count` records.
+    constexpr char Magic[8] = { 'M', 'K', 'T', 'R', 'A', 'C', 'E', '1' };
+
+    enum class BlockKind : std::uint32_t { Names = 1, Records = 2 };
+
+    struct BlockHeader {
+      BlockKind     kind;
+      std::uint32_t count;
+    };
+
+    struct Record {
+      std::uint64_t begin_ns;
+      std::uint64_t end_ns;
+      std::uint32_t thread;
+      std::uint32_t name_id;
+    };
+    static_assert( sizeof( Record ) == 24, "trace::Record must have a fixed on-disk size" );
+  } // namespace trace
+
+  // Asynchronous trace writer. Each thread appends fixed-size records to its own buffer without locking,
+  // full buffers are handed to a background thread that streams them to disk and recycles them.
+  // At most `max_buffers` buffers exist (by default two per thread). When the disk can't keep up and no
+  // buffer is free, records are dropped and counted instead of growing the memory.
+  class TraceWriter {
+  public:
+    TraceWriter( const std::string& filename, std::size_t num_threads, std::size_t buffer_records = 1 << 14,
+                 std::size_t max_buffers = 0 );
+    ~TraceWriter();
+
+    TraceWriter( const TraceWriter& )            = delete;
+    TraceWriter& operator=( const TraceWriter& ) = delete;
+
+    // Thread-safe, meant to be called once per distinct name and cached by the caller.
+    std::uint32_t name_id( const std::string& name );
+    // Must only be called by the thread owning the buffer `thread`.
+    void record( std::size_t thread, std::uint32_t name_id, std::uint64_t begin_ns, std::uint64_t end_ns );
+    // Nanoseconds since the writer was created.
+    std::uint64_t now() const {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - m_start ).count();
+    }
+    // Flushes remaining buffers and stops the background thread. Producers must be done before calling.
+    void close();
+    // Number of records dropped because no buffer was free. Only meaningful after `close()`.
+    std::uint64_t dropped() const;
+
+  private:
+    using Buffer = std::vector<trace::Record>;
+
+    struct alignas( 64 ) ThreadBuffer {
+      std::unique_ptr<Buffer> buffer;
+      std::uint64_t           dropped = 0;
+    };
+
+    void                    submit( std::unique_ptr<Buffer> buffer );
+    // Hands a full buffer to the flusher in exchange for a free one, fails if no buffer is available.
+    bool                    swap( std::unique_ptr<Buffer>& buffer );
+    std::unique_ptr<Buffer> allocate() const;
+    void                    flush_loop();
+    void                    write_names( const std::vector<std::pair<std::uint32_t, std::string>>& names );
+    void                    write_records( const Buffer& buffer );
+
+    const std::chrono::steady_clock::time_point m_start;
+    const std::size_t                           m_buffer_records;
+    const std::size_t                           m_max_buffers;
+    std::ofstream                               m_output;
+    std::vector<ThreadBuffer>                   m_threads;
+
+    std::mutex                                         m_mutex;
+    std::condition_variable                            m_cv;
+    std::deque<std::unique_ptr<Buffer>>                m_pending;
+    std::vector<std::unique_ptr<Buffer>>               m_free;
+    std::size_t                                        m_allocated = 0;
+    std::unordered_map<std::string, std::uint32_t>     m_names;
+    std::vector<std::pair<std::uint32_t, std::string>> m_pending_names;
+    bool                                               m_stop = false;
+    std::thread                                        m_flusher;
+  };
+
+  // Converts a trace produced by `TraceWriter` to the Chrome/Perfetto JSON trace format.
+  void convert_trace_to_chrome( std::istream& input, std::ostream& output );
+
+} // namespace mockup
+#endif // TASKFLOW_FWK_TRACE_WRITER_H_
@@ -1,5 +1,7 @@
 #include "mockup/cpu_cruncher.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <random>
 #include <ratio>
 #include <stdexcept>
@@ -56,14 +58,26 @@ namespace mockup {
     delete[] primes;
   }
 
+  // in precise mode durations shorter than the limit are crunched for the given fraction and the rest is spent
+  // spinning, longer durations are crunched as in the default mode
+  constexpr runtime_duration precise_spin_limit      = std::chrono::microseconds( 100 );
+  constexpr double           precise_crunch_fraction = 0.8;
+
   void detail::CPUCruncher::crunch( runtime_duration duration ) const {
-    auto iterations = get_iterations( duration );
-    find_primes( iterations );
+    if ( !m_precise || duration >= precise_spin_limit ) {
+      find_primes( get_iterations( duration ) );
+      return;
+    }
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>( duration );
+    find_primes( get_iterations( precise_crunch_fraction * duration ) );
+    while ( std::chrono::steady_clock::now() < deadline ) {}
   }
 
   // taken from GaudiHive/CPUCrunchSvc
   void detail::CPUCruncher::calibrate( double correction_factor, runtime_duration min_time, unsigned int min_runs,
-                                       bool fast_calibrate ) {
+                                       bool fast_calibrate, bool precise ) {
+    m_precise = precise;
     if ( m_niters_vect.size() == 0 ) {
       m_niters_vect = { 0,     500,   600,   700,   800,   1000,  1300,  1600,  2000,  2300,
                         2600,  3000,  3300,  3500,  3900,  4200,  5000,  6000,  8000,  10000,
@@ -75,6 +89,10 @@ namespace mockup {
         m_niters_vect.push_back( 300000 );
         m_niters_vect.push_back( 400000 );
       }
+      if ( precise ) {
+        // finer grid for sub-10 us durations
+        m_niters_vect.insert( m_niters_vect.begin() + 1, { 5, 10, 20, 35, 50, 75, 100, 150, 200, 300, 400 } );
+      }
     }
 
     if ( m_niters_vect.at( 0 ) != 0 ) { m_niters_vect.at( 0 ) = 0; }
@@ -91,12 +109,15 @@ namespace mockup {
       for ( unsigned int i = 1; i < m_niters_vect.size(); ++i ) {
         unsigned int niters = m_niters_vect.at( i );
         unsigned int trials = 30;
+        // in precise mode short runs are repeated and averaged so that the clock resolution doesn't dominate
+        unsigned int repeats = precise ? std::max( 1u, 10000 / niters ) : 1;
         do {
           auto start_cali = std::chrono::steady_clock::now();
-          find_primes( niters );
+          for ( unsigned int r = 0; r < repeats; ++r ) { find_primes( niters ); }
           auto stop_cali       = std::chrono::steady_clock::now();
-          auto deltat          = std::chrono::duration_cast<std::chrono::microseconds>( stop_cali - start_cali );
-          m_times_vect.at( i ) = deltat.count(); // in microseconds
+          auto deltat          = std::chrono::duration<double, std::micro>( stop_cali - start_cali ) / repeats;
+          // the default mode keeps whole microseconds
+          m_times_vect.at( i ) = precise ? deltat.count() : std::floor( deltat.count() ); // in microseconds
           // debug() << " Calibration: # iters = " << niters << " => " << m_times_vect.at( i ) << " us" << endmsg;
           trials--;
         } while ( trials > 0 && m_times_vect.at( i ) < m_times_vect.at( i - 1 ) ); // make sure that they are monotonic
@@ -111,7 +132,7 @@ namespace mockup {
         }
       }
     }
-    for ( auto& t : m_times_vect ) { t = t * correction_factor; }
+    for ( auto& t : m_times_vect ) { t = precise ? t * correction_factor : std::floor( t * correction_factor ); }
   }
 
   // taken from GaudiHive/CPUCrunchSvc
@@ -140,6 +161,7 @@ namespace mockup {
     const auto   x1 = m_times_vect.at( smaller_i + 1 );
     const auto   y0 = m_niters_vect.at( smaller_i );
     const auto   y1 = m_niters_vect.at( smaller_i + 1 );
+    if ( x1 <= x0 ) { return y0; }
     const double m  = (double)( y1 - y0 ) / (double)( x1 - x0 );
     const double q  = y0 - m * x0;
 
@@ -168,12 +190,14 @@ namespace mockup {
   }
 
   void CPUCruncher::operator()() {
-
-    auto distribution =
-        std::normal_distribution<runtime_duration::rep>{ m_duration_average.count(), m_duration_stddev.count() };
-    auto       random_duration = runtime_duration( std::abs( distribution( m_random ) ) );
-    const auto sleep_duration  = m_sleep_fraction * random_duration;
-    const auto work_duration   = ( 1 - m_sleep_fraction ) * random_duration;
+    auto random_duration = m_duration_average;
+    if ( m_duration_stddev.count() > 0 ) {
+      auto distribution =
+          std::normal_distribution<runtime_duration::rep>{ m_duration_average.count(), m_duration_stddev.count() };
+      random_duration = runtime_duration( std::abs( distribution( m_random ) ) );
+    }
+    const auto sleep_duration = m_sleep_fraction * random_duration;
+    const auto work_duration  = ( 1 - m_sleep_fraction ) * random_duration;
     if ( m_sleep_fraction > 0 ) { std::this_thread::sleep_for( sleep_duration ); }
     if ( m_sleep_fraction < 1 ) { m_cruncher->crunch( work_duration ); }
   }
@@ -0,0 +1,153 @@
+#include "mockup/event_source.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace mockup {
+
+  EventSource::EventSource( const std::string& filename, std::vector<std::size_t> event_sizes, std::size_t prefetch,
+                            Mode mode )
+      : m_event_sizes( std::move( event_sizes ) ), m_prefetch( std::max<std::size_t>( prefetch, 1 ) ), m_mode( mode ) {
+    if ( m_event_sizes.empty() ) { throw std::invalid_argument( "No event sizes given" ); }
+    m_fd = ::open( filename.c_str(), O_RDONLY );
+    if ( m_fd < 0 ) { throw std::runtime_error( "Can't open input file " + filename + ": " + std::strerror( errno ) ); }
+    struct stat status;
+    if ( ::fstat( m_fd, &status ) != 0 ) {
+      ::close( m_fd );
+      throw std::runtime_error( "Can't stat input file " + filename + ": " + std::strerror( errno ) );
+    }
+    m_file_size = status.st_size;
+    m_max_size  = *std::max_element( m_event_sizes.begin(), m_event_sizes.end() );
+    if ( m_max_size > m_file_size || m_max_size == 0 ) {
+      ::close( m_fd );
+      throw std::invalid_argument( "Event sizes must be between 1 B and the input file size" );
+    }
+
+    if ( m_mode == Mode::Mmap ) {
+      auto* mapping = ::mmap( nullptr, m_file_size, PROT_READ, MAP_SHARED, m_fd, 0 );
+      if ( mapping == MAP_FAILED ) {
+        ::close( m_fd );
+        throw std::runtime_error( "Can't map input file " + filename + ": " + std::strerror( errno ) );
+      }
+      m_mapping = static_cast<const std::byte*>( mapping );
+      for ( std::size_t i = 0; i < m_prefetch; ++i ) {
+        auto [offset, size] = advance( m_ahead );
+        advise( offset, size );
+      }
+    } else {
+      m_reader = std::thread( [this]() { read_loop(); } );
+    }
+  }
+
+  EventSource::~EventSource() {
+    if ( m_reader.joinable() ) {
+      {
+        auto lock = std::lock_guard{ m_mutex };
+        m_stop    = true;
+      }
+      m_space_cv.notify_one();
+      m_reader.join();
+    }
+    if ( m_mapping ) { ::munmap( const_cast<std::byte*>( m_mapping ), m_file_size ); }
+    ::close( m_fd );
+  }
+
+  EventBuffer EventSource::acquire() {
+    auto lock = std::unique_lock{ m_mutex };
+    if ( m_mode == Mode::Mmap ) {
+      auto [offset, size]      = advance( m_cursor );
+      auto [ahead, ahead_size] = advance( m_ahead );
+      advise( ahead, ahead_size );
+      return { m_mapping + offset, size, 0 };
+    }
+    m_ready_cv.wait( lock, [this]() { return !m_ready.empty() || m_error; } );
+    if ( m_error ) { std::rethrow_exception( m_error ); }
+    auto buffer = m_ready.front();
+    m_ready.pop_front();
+    m_space_cv.notify_one();
+    return buffer;
+  }
+
+  void EventSource::release( const EventBuffer& buffer ) {
+    if ( m_mode == Mode::Mmap ) { return; }
+    auto lock = std::lock_guard{ m_mutex };
+    m_free.push_back( buffer.index );
+  }
+
+  std::pair<std::size_t, std::size_t> EventSource::advance( Cursor& cursor ) const {
+    const auto size = m_event_sizes[cursor.event % m_event_sizes.size()];
+    if ( cursor.offset + size > m_file_size ) { cursor.offset = 0; }
+    const auto offset = cursor.offset;
+    cursor.offset += size;
+    ++cursor.event;
+    return { offset, size };
+  }
+
+  void EventSource::advise( std::size_t offset, std::size_t size ) const {
+    static const auto page_size = static_cast<std::size_t>( ::sysconf( _SC_PAGESIZE ) );
+    const auto        begin     = offset / page_size * page_size;
+    ::madvise( const_cast<std::byte*>( m_mapping ) + begin, offset + size - begin, MADV_WILLNEED );
+  }
+
+  void EventSource::read_loop() {
+    auto lock = std::unique_lock{ m_mutex };
+    while ( true ) {
+      m_space_cv.wait( lock, [this]() { return m_stop || m_ready.size() < m_prefetch; } );
+      if ( m_stop ) { break; }
+      // the pool only grows while all buffers are held by the consumer or are waiting in the read-ahead queue
+      if ( m_free.empty() ) {
+        m_free.push_back( m_buffers.size() );
+        m_buffers.push_back( std::make_unique<std::byte[]>( m_max_size ) );
+      }
+      const auto index = m_free.back();
+      m_free.pop_back();
+      auto* data          = m_buffers[index].get();
+      auto [offset, size] = advance( m_cursor );
+      lock.unlock();
+
+      auto error = std::exception_ptr{};
+      for ( std::size_t done = 0; done < size; ) {
+        const auto n = ::pread( m_fd, data + done, size - done, offset + done );
+        if ( n <= 0 ) {
+          error = std::make_exception_ptr(
+              std::runtime_error( std::string( "Can't read input file: " ) + std::strerror( n < 0 ? errno : EIO ) ) );
+          break;
+        }
+        done += n;
+      }
+
+      lock.lock();
+      if ( error ) {
+        m_error = error;
+        m_ready_cv.notify_all();
+        break;
+      }
+      m_ready.push_back( { data, size, index } );
+      m_ready_cv.notify_one();
+    }
+  }
+
+  std::vector<std::size_t> read_event_sizes( const std::string& filename ) {
+    std::ifstream ifs( filename.c_str() );
+    if ( !ifs ) { throw std::runtime_error( "Can't open event sizes file: " + filename ); }
+    auto sizes = std::vector<std::size_t>{};
+    for ( std::size_t size; ifs >> size; ) { sizes.push_back( size ); }
+    if ( !ifs.eof() || sizes.empty() ) { throw std::runtime_error( "Invalid event sizes file: " + filename ); }
+    return sizes;
+  }
+
+  std::uint64_t consume_payload( const EventBuffer& buffer ) {
+    constexpr std::size_t cache_line = 64;
+    auto                  checksum   = std::uint64_t{ 0 };
+    for ( std::size_t i = 0; i < buffer.size; i += cache_line ) {
+      checksum += std::to_integer<std::uint8_t>( buffer.data[i] );
+    }
+    return checksum;
+  }
+
+} // namespace mockup
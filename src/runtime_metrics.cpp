@@ -0,0 +1,268 @@
+#include "mockup/runtime_metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <poll.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+namespace mockup {
+
+  namespace {
+    constexpr auto UnixSocketPrefix = "unix:";
+
+    std::int64_t now_ns() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() )
+          .count();
+    }
+
+    std::string escape_label( const std::string& value ) {
+      auto escaped = std::string{};
+      escaped.reserve( value.size() );
+      for ( char c : value ) {
+        if ( c == '\\' || c == '"' ) {
+          escaped += '\\';
+          escaped += c;
+        } else if ( c == '\n' ) {
+          escaped += "\\n";
+        } else {
+          escaped += c;
+        }
+      }
+      return escaped;
+    }
+
+    // Removes a socket left behind at `path` by a previous run, refusing to remove anything else.
+    void remove_stale_socket( const std::string& path ) {
+      struct stat status;
+      if ( ::lstat( path.c_str(), &status ) != 0 ) {
+        if ( errno == ENOENT ) { return; }
+        throw std::runtime_error( "Can't stat metrics socket " + path + ": " + std::strerror( errno ) );
+      }
+      if ( !S_ISSOCK( status.st_mode ) ) {
+        throw std::invalid_argument( "Metrics socket path exists and isn't a socket: " + path );
+      }
+      ::unlink( path.c_str() );
+    }
+
+    void write_metric( std::ostream& output, const char* name, const char* type, const char* help ) {
+      output << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+    }
+  } // namespace
+
+  RuntimeMetrics::RuntimeMetrics( std::size_t num_workers )
+      : m_num_workers( num_workers ), m_workers( std::make_unique<WorkerState[]>( num_workers ) ) {}
+
+  void RuntimeMetrics::task_entry( std::size_t worker, const std::string& name ) {
+    auto& state = m_workers[worker];
+    state.begin_ns.store( now_ns(), std::memory_order_relaxed );
+    state.task.store( &name, std::memory_order_release );
+  }
+
+  void RuntimeMetrics::task_exit( std::size_t worker ) {
+    auto& state = m_workers[worker];
+    state.task.store( nullptr, std::memory_order_release );
+    // only the owning worker writes, so a plain load and store is enough
+    state.busy_ns.store( state.busy_ns.load( std::memory_order_relaxed ) + now_ns() -
+                             state.begin_ns.load( std::memory_order_relaxed ),
+                         std::memory_order_relaxed );
+  }
+
+  std::uint64_t RuntimeMetrics::slots_in_flight() const {
+    const auto completed = m_events_completed.load( std::memory_order_relaxed );
+    const auto started   = m_events_started.load( std::memory_order_relaxed );
+    return started > completed ? started - completed : 0;
+  }
+
+  double RuntimeMetrics::busy_seconds() const {
+    auto busy_ns = std::int64_t{ 0 };
+    for ( std::size_t i = 0; i < m_num_workers; ++i ) {
+      busy_ns += m_workers[i].busy_ns.load( std::memory_order_relaxed );
+    }
+    return busy_ns * 1e-9;
+  }
+
+  MetricsSample RuntimeMetrics::sample( std::size_t top ) const {
+    auto sample             = MetricsSample{};
+    sample.events_completed = m_events_completed.load( std::memory_order_relaxed );
+    sample.slots_in_flight  = slots_in_flight();
+
+    const auto now = now_ns();
+    for ( std::size_t i = 0; i < m_num_workers; ++i ) {
+      const auto& state = m_workers[i];
+      sample.ready_queue_depth += state.queue_size.load( std::memory_order_relaxed );
+      const auto* task = state.task.load( std::memory_order_acquire );
+      if ( task ) {
+        ++sample.busy_workers;
+        const auto begin = state.begin_ns.load( std::memory_order_relaxed );
+        sample.longest_running.push_back( { i, *task, std::max<std::int64_t>( now - begin, 0 ) * 1e-9 } );
+      }
+    }
+    sample.idle_workers = m_num_workers - sample.busy_workers;
+
+    std::sort( sample.longest_running.begin(), sample.longest_running.end(),
+               []( const auto& a, const auto& b ) { return a.elapsed_s > b.elapsed_s; } );
+    if ( sample.longest_running.size() > top ) { sample.longest_running.resize( top ); }
+    return sample;
+  }
+
+  void format_prometheus( const MetricsSample& sample, std::ostream& output ) {
+    write_metric( output, "mockup_events_completed_total", "counter", "Number of events completed." );
+    output << "mockup_events_completed_total " << sample.events_completed << '\n';
+    write_metric( output, "mockup_throughput_events_per_second", "gauge",
+                  "Event throughput over the rolling window." );
+    output << "mockup_throughput_events_per_second " << sample.throughput << '\n';
+    write_metric( output, "mockup_slots_in_flight", "gauge", "Number of events currently being processed." );
+    output << "mockup_slots_in_flight " << sample.slots_in_flight << '\n';
+    write_metric( output, "mockup_ready_queue_depth", "gauge",
+                  "Number of tasks waiting in the worker queues, excluding the executor shared queue." );
+    output << "mockup_ready_queue_depth " << sample.ready_queue_depth << '\n';
+    write_metric( output, "mockup_workers", "gauge", "Number of workers by state." );
+    output << "mockup_workers{state=\"busy\"} " << sample.busy_workers << '\n';
+    output << "mockup_workers{state=\"idle\"} " << sample.idle_workers << '\n';
+    write_metric( output, "mockup_algorithm_running_seconds", "gauge",
+                  "Elapsed time of the longest running algorithms." );
+    for ( const auto& task : sample.longest_running ) {
+      output << "mockup_algorithm_running_seconds{worker=\"" << task.worker << "\",algorithm=\""
+             << escape_label( task.name ) << "\"} " << task.elapsed_s << '\n';
+    }
+  }
+
+  MetricsExporter::MetricsExporter( const RuntimeMetrics& metrics, std::string target,
+                                    std::chrono::milliseconds period, std::chrono::milliseconds window,
+                                    std::size_t top )
+      : m_metrics( metrics ), m_target( std::move( target ) ), m_period( period ), m_window( window ), m_top( top ) {
+    if ( m_target.rfind( UnixSocketPrefix, 0 ) == 0 ) {
+      const auto path    = m_target.substr( std::strlen( UnixSocketPrefix ) );
+      auto       address = sockaddr_un{};
+      if ( path.size() >= sizeof( address.sun_path ) ) {
+        throw std::invalid_argument( "Unix socket path too long: " + path );
+      }
+      address.sun_family = AF_UNIX;
+      std::strncpy( address.sun_path, path.c_str(), sizeof( address.sun_path ) - 1 );
+      remove_stale_socket( path );
+      m_socket = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+      struct stat status;
+      if ( m_socket < 0 || ::bind( m_socket, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) != 0 ||
+           ::lstat( path.c_str(), &status ) != 0 || ::listen( m_socket, 8 ) != 0 ||
+           ::fcntl( m_socket, F_SETFL, O_NONBLOCK ) != 0 ) {
+        const auto error = std::string( std::strerror( errno ) );
+        if ( m_socket >= 0 ) { ::close( m_socket ); }
+        throw std::runtime_error( "Can't listen on metrics socket " + path + ": " + error );
+      }
+      m_socket_id = { status.st_dev, status.st_ino };
+    } else {
+      // fail early on an unwritable target
+      publish( std::string{} );
+    }
+    m_sampler = std::thread( [this]() { run(); } );
+  }
+
+  MetricsExporter::~MetricsExporter() {
+    stop();
+    if ( m_socket >= 0 ) {
+      ::close( m_socket );
+      // only remove the socket if it is still the one bound here
+      const auto  path = m_target.substr( std::strlen( UnixSocketPrefix ) );
+      struct stat status;
+      if ( ::lstat( path.c_str(), &status ) == 0 && S_ISSOCK( status.st_mode ) &&
+           std::make_pair( status.st_dev, status.st_ino ) == m_socket_id ) {
+        ::unlink( path.c_str() );
+      }
+    }
+  }
+
+  void MetricsExporter::stop() {
+    if ( !m_sampler.joinable() ) { return; }
+    {
+      auto lock = std::lock_guard{ m_mutex };
+      m_stop    = true;
+    }
+    m_cv.notify_one();
+    m_sampler.join();
+  }
+
+  std::string MetricsExporter::error() const {
+    auto lock = std::lock_guard{ m_mutex };
+    return m_error;
+  }
+
+  void MetricsExporter::run() {
+    auto next    = clock::now();
+    auto stopped = false;
+    while ( true ) {
+      const auto now    = clock::now();
+      auto       sample = m_metrics.sample( m_top );
+      m_history.emplace_back( now, sample.events_completed );
+      while ( m_history.size() > 2 && now - m_history[1].first >= m_window ) { m_history.pop_front(); }
+      const auto elapsed = std::chrono::duration<double>( now - m_history.front().first ).count();
+      if ( elapsed > 0 ) { sample.throughput = ( sample.events_completed - m_history.front().second ) / elapsed; }
+
+      auto text = std::ostringstream{};
+      format_prometheus( sample, text );
+      try {
+        publish( text.str() );
+      } catch ( const std::runtime_error& ex ) {
+        auto lock = std::lock_guard{ m_mutex };
+        m_error   = ex.what();
+      }
+      if ( stopped ) { break; }
+
+      next += m_period;
+      if ( m_socket >= 0 ) {
+        serve( text.str(), next );
+        auto lock = std::lock_guard{ m_mutex };
+        stopped   = m_stop;
+      } else {
+        auto lock = std::unique_lock{ m_mutex };
+        stopped   = m_cv.wait_until( lock, next, [this]() { return m_stop; } );
+      }
+    }
+  }
+
+  void MetricsExporter::publish( const std::string& text ) {
+    if ( m_socket >= 0 ) { return; }
+    const auto tmp_file_name = m_target + ".tmp";
+    {
+      auto output = std::ofstream( tmp_file_name );
+      output << text;
+      output.close();
+      if ( !output ) { throw std::runtime_error( "Can't write metrics file " + tmp_file_name ); }
+    }
+    if ( std::rename( tmp_file_name.c_str(), m_target.c_str() ) != 0 ) {
+      throw std::runtime_error( "Can't replace metrics file " + m_target + ": " + std::strerror( errno ) );
+    }
+  }
+
+  void MetricsExporter::serve( const std::string& text, clock::time_point until ) {
+    // poll in short steps so that stop() doesn't wait for the whole period
+    constexpr auto step = std::chrono::milliseconds( 50 );
+    for ( auto now = clock::now(); now < until; now = clock::now() ) {
+      {
+        auto lock = std::lock_guard{ m_mutex };
+        if ( m_stop ) { return; }
+      }
+      auto timeout = std::min<clock::duration>( until - now, step );
+      auto fd      = pollfd{ m_socket, POLLIN, 0 };
+      if ( ::poll( &fd, 1, std::chrono::duration_cast<std::chrono::milliseconds>( timeout ).count() ) <= 0 ) {
+        continue;
+      }
+      for ( int client = ::accept( m_socket, nullptr, nullptr ); client >= 0;
+            client = ::accept( m_socket, nullptr, nullptr ) ) {
+        for ( std::size_t sent = 0; sent < text.size(); ) {
+          const auto n = ::send( client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL );
+          if ( n <= 0 ) { break; }
+          sent += n;
+        }
+        ::close( client );
+      }
+    }
+  }
+
+} // namespace mockup
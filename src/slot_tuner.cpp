@@ -0,0 +1,113 @@
+#include "mockup/slot_tuner.h"
+#include <algorithm>
+#include <stdexcept>
+namespace mockup {
+
+  SlotTuner::SlotTuner( unsigned int initial, unsigned int max_slots, double tolerance, double idle_threshold )
+      : m_target( std::clamp( initial, 1u, std::max( max_slots, 1u ) ) )
+      , m_max_slots( std::max( max_slots, 1u ) )
+      , m_tolerance( tolerance )
+      , m_idle_threshold( idle_threshold )
+      , m_step( std::max( m_max_slots / 4, 1u ) )
+      , m_measurements( m_max_slots + 1 ) {
+    if ( tolerance < 0 ) { throw std::domain_error( "Slot tuner tolerance can't be negative" ); }
+  }
+
+  unsigned int SlotTuner::update( double throughput, double idle_fraction ) {
+    const auto current = target();
+    m_measurements[current].first += throughput;
+    m_measurements[current].second += 1;
+
+    if ( m_last_throughput < 0 ) {
+      m_direction = idle_fraction > m_idle_threshold ? 1 : -1;
+    } else if ( throughput < m_last_throughput * ( 1 - m_tolerance ) ) {
+      m_direction = -m_direction;
+      m_step      = std::max( m_step / 2, 1u );
+    } else if ( throughput <= m_last_throughput * ( 1 + m_tolerance ) ) {
+      m_direction = idle_fraction > m_idle_threshold ? 1 : -1;
+    }
+    m_last_throughput = throughput;
+
+    auto next = static_cast<int>( current ) + m_direction * static_cast<int>( m_step );
+    next      = std::clamp( next, 1, static_cast<int>( m_max_slots ) );
+    if ( static_cast<unsigned int>( next ) == current ) {
+      // hit a bound, bounce back from it
+      m_direction = -m_direction;
+      next        = std::clamp( next + m_direction, 1, static_cast<int>( m_max_slots ) );
+    }
+    m_target.store( next, std::memory_order_relaxed );
+    return next;
+  }
+
+  void SlotTuner::set_target( unsigned int slots ) {
+    m_target.store( std::clamp( slots, 1u, m_max_slots ), std::memory_order_relaxed );
+  }
+
+  double SlotTuner::throughput( unsigned int slots ) const {
+    if ( slots >= m_measurements.size() || m_measurements[slots].second == 0 ) { return 0; }
+    return m_measurements[slots].first / m_measurements[slots].second;
+  }
+
+  unsigned int SlotTuner::converged() const {
+    auto best = 0.;
+    for ( unsigned int slots = 1; slots <= m_max_slots; ++slots ) { best = std::max( best, throughput( slots ) ); }
+    for ( unsigned int slots = 1; slots <= m_max_slots; ++slots ) {
+      if ( best > 0 && throughput( slots ) >= best * ( 1 - m_tolerance ) ) { return slots; }
+    }
+    return target();
+  }
+
+  SlotController::SlotController( const RuntimeMetrics& metrics, SlotTuner& tuner, std::chrono::milliseconds period )
+      : m_metrics( metrics ), m_tuner( tuner ), m_period( period ) {
+    m_controller = std::thread( [this]() { run(); } );
+  }
+
+  SlotController::~SlotController() { stop(); }
+
+  void SlotController::stop() {
+    if ( !m_controller.joinable() ) { return; }
+    {
+      auto lock = std::lock_guard{ m_mutex };
+      m_stop    = true;
+    }
+    m_cv.notify_one();
+    m_controller.join();
+  }
+
+  void SlotController::run() {
+    using clock         = std::chrono::steady_clock;
+    auto last_time      = clock::now();
+    auto last_completed = m_metrics.events_completed();
+    auto last_busy      = m_metrics.busy_seconds();
+    auto last_run       = m_metrics.source_runs();
+    auto last_active    = m_metrics.source_active();
+    auto warm           = false; // an event of the current run completed before the period began
+    auto settling       = false; // the target changed at the beginning of the period
+    auto lock           = std::unique_lock{ m_mutex };
+    while ( !m_cv.wait_for( lock, m_period, [this]() { return m_stop; } ) ) {
+      const auto now       = clock::now();
+      const auto completed = m_metrics.events_completed();
+      const auto busy      = m_metrics.busy_seconds();
+      const auto run       = m_metrics.source_runs();
+      const auto active    = m_metrics.source_active();
+      const auto elapsed   = std::chrono::duration<double>( now - last_time ).count();
+      // the source issued events throughout the period if it was active at both ends and wasn't restarted
+      const auto steady = last_active && active && run == last_run;
+      if ( steady && warm && !settling ) {
+        const auto throughput = ( completed - last_completed ) / elapsed;
+        const auto idle       = 1 - ( busy - last_busy ) / ( elapsed * m_metrics.num_workers() );
+        const auto previous   = m_tuner.target();
+        settling              = m_tuner.update( throughput, std::clamp( idle, 0., 1. ) ) != previous;
+      } else {
+        settling = false;
+      }
+      warm           = steady && ( warm || completed > last_completed );
+      last_time      = now;
+      last_completed = completed;
+      last_busy      = busy;
+      last_run       = run;
+      last_active    = active;
+    }
+  }
+
+} // namespace mockup
@@ -0,0 +1,206 @@
+#include "mockup/trace_writer.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+namespace mockup {
+
+  TraceWriter::TraceWriter( const std::string& filename, std::size_t num_threads, std::size_t buffer_records,
+                            std::size_t max_buffers )
+      : m_start( std::chrono::steady_clock::now() )
+      , m_buffer_records( std::max<std::size_t>( buffer_records, 1 ) )
+      , m_max_buffers( std::max( max_buffers > 0 ? max_buffers : 2 * num_threads, num_threads + 1 ) )
+      , m_output( filename, std::ios::binary )
+      , m_threads( num_threads ) {
+    if ( !m_output ) { throw std::runtime_error( "Can't open trace file: " + filename ); }
+    m_output.write( trace::Magic, sizeof( trace::Magic ) );
+    for ( auto& thread : m_threads ) { thread.buffer = allocate(); }
+    m_allocated = num_threads;
+    m_flusher = std::thread( [this]() { flush_loop(); } );
+  }
+
+  TraceWriter::~TraceWriter() { close(); }
+
+  std::uint32_t TraceWriter::name_id( const std::string& name ) {
+    auto lock = std::lock_guard{ m_mutex };
+    auto [it, inserted] = m_names.try_emplace( name, static_cast<std::uint32_t>( m_names.size() ) );
+    if ( inserted ) { m_pending_names.emplace_back( it->second, name ); }
+    return it->second;
+  }
+
+  void TraceWriter::record( std::size_t thread, std::uint32_t name_id, std::uint64_t begin_ns,
+                            std::uint64_t end_ns ) {
+    auto& state = m_threads[thread];
+    if ( state.buffer->size() == m_buffer_records && !swap( state.buffer ) ) {
+      ++state.dropped;
+      return;
+    }
+    state.buffer->push_back( { begin_ns, end_ns, static_cast<std::uint32_t>( thread ), name_id } );
+  }
+
+  std::uint64_t TraceWriter::dropped() const {
+    auto dropped = std::uint64_t{ 0 };
+    for ( const auto& thread : m_threads ) { dropped += thread.dropped; }
+    return dropped;
+  }
+
+  void TraceWriter::close() {
+    if ( !m_flusher.joinable() ) { return; }
+    for ( auto& thread : m_threads ) {
+      if ( !thread.buffer->empty() ) { submit( std::move( thread.buffer ) ); }
+    }
+    {
+      auto lock = std::lock_guard{ m_mutex };
+      m_stop    = true;
+    }
+    m_cv.notify_one();
+    m_flusher.join();
+    m_output.close();
+  }
+
+  void TraceWriter::submit( std::unique_ptr<Buffer> buffer ) {
+    {
+      auto lock = std::lock_guard{ m_mutex };
+      m_pending.push_back( std::move( buffer ) );
+    }
+    m_cv.notify_one();
+  }
+
+  bool TraceWriter::swap( std::unique_ptr<Buffer>& buffer ) {
+    auto next = std::unique_ptr<Buffer>{};
+    {
+      auto lock = std::lock_guard{ m_mutex };
+      if ( !m_free.empty() ) {
+        next = std::move( m_free.back() );
+        m_free.pop_back();
+      } else if ( m_allocated < m_max_buffers ) {
+        ++m_allocated;
+      } else {
+        return false;
+      }
+      m_pending.push_back( std::move( buffer ) );
+    }
+    m_cv.notify_one();
+    buffer = next ? std::move( next ) : allocate();
+    return true;
+  }
+
+  std::unique_ptr<TraceWriter::Buffer> TraceWriter::allocate() const {
+    auto buffer = std::make_unique<Buffer>();
+    buffer->reserve( m_buffer_records );
+    return buffer;
+  }
+
+  void TraceWriter::flush_loop() {
+    auto lock = std::unique_lock{ m_mutex };
+    while ( true ) {
+      m_cv.wait( lock, [this]() { return m_stop || !m_pending.empty() || !m_pending_names.empty(); } );
+      // names are written before the records submitted after their registration
+      auto names  = std::move( m_pending_names );
+      auto buffer = std::unique_ptr<Buffer>{};
+      m_pending_names.clear();
+      if ( !m_pending.empty() ) {
+        buffer = std::move( m_pending.front() );
+        m_pending.pop_front();
+      }
+      if ( names.empty() && !buffer ) {
+        if ( m_stop ) { break; }
+        continue;
+      }
+      lock.unlock();
+      if ( !names.empty() ) { write_names( names ); }
+      if ( buffer ) {
+        write_records( *buffer );
+        buffer->clear();
+      }
+      lock.lock();
+      if ( buffer ) { m_free.push_back( std::move( buffer ) ); }
+    }
+    m_output.flush();
+  }
+
+  void TraceWriter::write_names( const std::vector<std::pair<std::uint32_t, std::string>>& names ) {
+    const auto header = trace::BlockHeader{ trace::BlockKind::Names, static_cast<std::uint32_t>( names.size() ) };
+    m_output.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    for ( const auto& [id, name] : names ) {
+      const auto length = static_cast<std::uint32_t>( name.size() );
+      m_output.write( reinterpret_cast<const char*>( &id ), sizeof( id ) );
+      m_output.write( reinterpret_cast<const char*>( &length ), sizeof( length ) );
+      m_output.write( name.data(), length );
+    }
+  }
+
+  void TraceWriter::write_records( const Buffer& buffer ) {
+    const auto header = trace::BlockHeader{ trace::BlockKind::Records, static_cast<std::uint32_t>( buffer.size() ) };
+    m_output.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    m_output.write( reinterpret_cast<const char*>( buffer.data() ), buffer.size() * sizeof( trace::Record ) );
+  }
+
+  namespace {
+    template <typename T>
+    bool read_value( std::istream& input, T& value ) {
+      return static_cast<bool>( input.read( reinterpret_cast<char*>( &value ), sizeof( value ) ) );
+    }
+
+    void write_json_string( std::ostream& output, const std::string& value ) {
+      output << '"';
+      for ( char c : value ) {
+        switch ( c ) {
+        case '"':
+          output << "\\\"";
+          break;
+        case '\\':
+          output << "\\\\";
+          break;
+        default:
+          if ( static_cast<unsigned char>( c ) < 0x20 ) {
+            output << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << static_cast<int>( c ) << std::dec;
+          } else {
+            output << c;
+          }
+        }
+      }
+      output << '"';
+    }
+  } // namespace
+
+  void convert_trace_to_chrome( std::istream& input, std::ostream& output ) {
+    char magic[sizeof( trace::Magic )];
+    if ( !input.read( magic, sizeof( magic ) ) || std::memcmp( magic, trace::Magic, sizeof( magic ) ) != 0 ) {
+      throw std::runtime_error( "Input is not a binary trace" );
+    }
+    auto names  = std::unordered_map<std::uint32_t, std::string>{};
+    auto header = trace::BlockHeader{};
+    auto record = trace::Record{};
+    auto first  = true;
+    output << "{\"traceEvents\":[";
+    while ( read_value( input, header ) ) {
+      for ( std::uint32_t i = 0; i < header.count; ++i ) {
+        if ( header.kind == trace::BlockKind::Names ) {
+          auto id     = std::uint32_t{};
+          auto length = std::uint32_t{};
+          if ( !read_value( input, id ) || !read_value( input, length ) ) {
+            throw std::runtime_error( "Truncated name block" );
+          }
+          auto name = std::string( length, '\0' );
+          if ( !input.read( name.data(), length ) ) { throw std::runtime_error( "Truncated name block" ); }
+          names[id] = std::move( name );
+        } else if ( header.kind == trace::BlockKind::Records ) {
+          if ( !read_value( input, record ) ) { throw std::runtime_error( "Truncated record block" ); }
+          auto name = names.find( record.name_id );
+          output << ( first ? "" : "," ) << "\n{\"cat\":\"TaskflowFwk\",\"name\":";
+          write_json_string( output, name != names.end() ? name->second : std::to_string( record.name_id ) );
+          output << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << record.thread << ",\"ts\":" << record.begin_ns / 1000
+                 << '.' << std::setw( 3 ) << std::setfill( '0' ) << record.begin_ns % 1000
+                 << ",\"dur\":" << ( record.end_ns - record.begin_ns ) / 1000 << '.' << std::setw( 3 )
+                 << std::setfill( '0' ) << ( record.end_ns - record.begin_ns ) % 1000 << '}';
+          first = false;
+        } else {
+          throw std::runtime_error( "Unknown trace block kind" );
+        }
+      }
+    }
+    output << "\n]}\n";
+  }
+
+} // namespace mockup
@@ -1,15 +1,42 @@
 #include "mockup/cpu_cruncher.h"
-#include "chrono"
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <vector>
 using namespace mockup;
 
 TEST_CASE( "CPUCruncher", "[timing]" ) {
+  auto builder = CPUCruncherBuilder{};
+  builder.calibrate( 1, runtime_duration( 0 ), 1, true );
   auto average  = std::chrono::milliseconds( 5 );
-  auto cruncher = CPUCruncher().average( average ).sleep_fraction( .5 ).variance( std::chrono::milliseconds( 0 ) );
+  auto cruncher = builder.make().average( average ).sleep_fraction( .5 ).stddev( std::chrono::milliseconds( 0 ) );
   auto start    = std::chrono::steady_clock::now();
   cruncher();
   auto stop    = std::chrono::steady_clock::now();
   auto runtime = stop - start;
   REQUIRE( average * 1.1 > runtime );
   REQUIRE( runtime > average * 0.9 );
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Precise CPUCruncher", "[timing]" ) {
+  auto builder = CPUCruncherBuilder{};
+  builder.calibrate( 1, runtime_duration( 0 ), 1, true, true );
+  // only short durations spin up to their deadline
+  for ( auto average : { std::chrono::microseconds( 1 ), std::chrono::microseconds( 10 ),
+                         std::chrono::microseconds( 50 ) } ) {
+    auto cruncher = builder.make().average( average ).stddev( std::chrono::microseconds( 0 ) );
+    auto runtimes = std::vector<std::chrono::steady_clock::duration>( 101 );
+    for ( auto& runtime : runtimes ) {
+      auto start = std::chrono::steady_clock::now();
+      cruncher();
+      runtime = std::chrono::steady_clock::now() - start;
+      REQUIRE( runtime >= average );
+    }
+    // the clock overhead dominates a single microsecond
+    if ( average >= std::chrono::microseconds( 10 ) ) {
+      auto median = runtimes.begin() + runtimes.size() / 2;
+      std::nth_element( runtimes.begin(), median, runtimes.end() );
+      REQUIRE( *median <= average * 1.5 );
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#include "mockup/event_source.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+using namespace mockup;
+
+TEST_CASE( "EventSource", "[input]" ) {
+  const auto filename = ( std::filesystem::temp_directory_path() / "mockup_event_source.test.bin" ).string();
+  auto       content  = std::vector<char>( 1000 );
+  for ( std::size_t i = 0; i < content.size(); ++i ) { content[i] = static_cast<char>( i % 251 ); }
+  {
+    auto output = std::ofstream( filename, std::ios::binary );
+    output.write( content.data(), content.size() );
+  }
+  // the sixth event doesn't fit before the end of the file and wraps around to the beginning
+  const auto expected_offsets = std::vector<std::size_t>{ 0, 100, 400, 500, 800, 0, 300, 400 };
+  const auto sizes            = std::vector<std::size_t>{ 100, 300 };
+
+  for ( auto mode : { EventSource::Mode::Mmap, EventSource::Mode::Read } ) {
+    auto source  = EventSource( filename, sizes, 2, mode );
+    auto buffers = std::set<const std::byte*>{};
+    for ( std::size_t i = 0; i < expected_offsets.size(); ++i ) {
+      auto buffer = source.acquire();
+      REQUIRE( buffer.size == sizes[i % 2] );
+      REQUIRE( std::memcmp( buffer.data, content.data() + expected_offsets[i], buffer.size ) == 0 );
+      REQUIRE( consume_payload( buffer ) > 0 );
+      buffers.insert( buffer.data );
+      source.release( buffer );
+    }
+    if ( mode == EventSource::Mode::Read ) {
+      // one buffer held by the consumer and at most two read ahead
+      REQUIRE( buffers.size() <= 3 );
+    }
+  }
+
+  REQUIRE_THROWS( EventSource( filename, { 2000 }, 1 ) );
+  std::filesystem::remove( filename );
+}
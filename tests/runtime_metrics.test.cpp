@@ -0,0 +1,68 @@
+#include "mockup/runtime_metrics.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+using namespace mockup;
+
+TEST_CASE( "RuntimeMetrics", "[metrics]" ) {
+  auto       metrics = RuntimeMetrics( 3 );
+  const auto alg_a   = std::string( "AlgA" );
+  const auto alg_b   = std::string( "Alg\"B" );
+  for ( auto i = 0; i < 4; ++i ) { metrics.event_started(); }
+  metrics.event_completed();
+  metrics.task_entry( 0, alg_a );
+  metrics.task_entry( 2, alg_b );
+  metrics.queue_size( 0, 5 );
+  metrics.queue_size( 1, 2 );
+
+  SECTION( "Sample" ) {
+    auto sample = metrics.sample( 5 );
+    REQUIRE( sample.events_completed == 1 );
+    REQUIRE( sample.slots_in_flight == 3 );
+    REQUIRE( metrics.slots_in_flight() == 3 );
+    REQUIRE( sample.ready_queue_depth == 7 );
+    REQUIRE( sample.busy_workers == 2 );
+    REQUIRE( sample.idle_workers == 1 );
+    REQUIRE( sample.longest_running.size() == 2 );
+    REQUIRE( sample.longest_running.front().name == "AlgA" );
+    REQUIRE( sample.longest_running.front().elapsed_s >= sample.longest_running.back().elapsed_s );
+
+    metrics.task_exit( 0 );
+    REQUIRE( metrics.busy_seconds() > 0 );
+    REQUIRE( metrics.sample( 1 ).busy_workers == 1 );
+    REQUIRE( metrics.sample( 1 ).longest_running.front().worker == 2 );
+  }
+  SECTION( "Prometheus text" ) {
+    auto text = std::ostringstream{};
+    format_prometheus( metrics.sample( 5 ), text );
+    REQUIRE( text.str().find( "# TYPE mockup_events_completed_total counter\nmockup_events_completed_total 1\n" ) !=
+             std::string::npos );
+    REQUIRE( text.str().find( "mockup_workers{state=\"idle\"} 1\n" ) != std::string::npos );
+    REQUIRE( text.str().find( "algorithm=\"Alg\\\"B\"" ) != std::string::npos );
+  }
+  SECTION( "Export to file" ) {
+    const auto filename = ( std::filesystem::temp_directory_path() / "mockup_runtime_metrics.test.prom" ).string();
+    auto       exporter = MetricsExporter( metrics, filename, std::chrono::milliseconds( 10 ) );
+    metrics.event_completed();
+    exporter.stop();
+    auto input = std::ifstream( filename );
+    auto text  = std::stringstream{};
+    text << input.rdbuf();
+    REQUIRE( text.str().find( "mockup_events_completed_total 2\n" ) != std::string::npos );
+    REQUIRE( exporter.error().empty() );
+    std::filesystem::remove( filename );
+  }
+  SECTION( "Invalid targets" ) {
+    const auto directory = std::filesystem::temp_directory_path() / "mockup_runtime_metrics.test.missing";
+    REQUIRE_THROWS_AS( MetricsExporter( metrics, ( directory / "metrics.prom" ).string() ), std::runtime_error );
+
+    const auto filename = ( std::filesystem::temp_directory_path() / "mockup_runtime_metrics.test.txt" ).string();
+    std::ofstream( filename ) << "keep";
+    REQUIRE_THROWS_AS( MetricsExporter( metrics, "unix:" + filename ), std::invalid_argument );
+    REQUIRE( std::filesystem::is_regular_file( filename ) );
+    std::filesystem::remove( filename );
+  }
+}
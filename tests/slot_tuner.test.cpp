@@ -0,0 +1,65 @@
+#include "mockup/slot_tuner.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+using namespace mockup;
+
+namespace {
+  // throughput grows linearly until the workers are saturated at 6 slots and then degrades with memory pressure
+  double modelled_throughput( unsigned int slots ) {
+    return std::min( slots, 6u ) * 100. - std::max( static_cast<int>( slots ) - 6, 0 ) * 20.;
+  }
+  double modelled_idle_fraction( unsigned int slots ) { return slots < 6 ? 1 - slots / 6. : 0.; }
+} // namespace
+
+TEST_CASE( "SlotTuner", "[tuning]" ) {
+  SECTION( "Converges to the throughput peak" ) {
+    for ( auto initial : { 1u, 4u, 16u } ) {
+      auto tuner = SlotTuner( initial, 16 );
+      for ( auto i = 0; i < 40; ++i ) {
+        const auto slots = tuner.target();
+        tuner.update( modelled_throughput( slots ), modelled_idle_fraction( slots ) );
+        REQUIRE( tuner.target() >= 1 );
+        REQUIRE( tuner.target() <= 16 );
+      }
+      REQUIRE( tuner.converged() == 6 );
+      REQUIRE( tuner.throughput( 6 ) == modelled_throughput( 6 ) );
+      REQUIRE( tuner.throughput( 6 ) >= tuner.throughput( initial ) );
+    }
+  }
+  SECTION( "Prefers fewer slots on a plateau" ) {
+    auto tuner = SlotTuner( 8, 8 );
+    for ( auto i = 0; i < 20; ++i ) { tuner.update( 100, 0 ); }
+    REQUIRE( tuner.converged() == 1 );
+  }
+}
+
+TEST_CASE( "SlotController", "[tuning]" ) {
+  auto metrics    = RuntimeMetrics( 1 );
+  auto tuner      = SlotTuner( 4, 8 );
+  auto controller = SlotController( metrics, tuner, std::chrono::milliseconds( 10 ) );
+
+  SECTION( "Skips periods without an active source" ) {
+    for ( auto i = 0; i < 10; ++i ) {
+      metrics.event_completed();
+      std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    }
+    controller.stop();
+    REQUIRE( tuner.target() == 4 );
+    REQUIRE( tuner.throughput( 4 ) == 0 );
+  }
+  SECTION( "Measures once the first event completed" ) {
+    metrics.source_started();
+    // several completions per period
+    for ( auto i = 0; i < 100; ++i ) {
+      metrics.event_completed();
+      std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+    }
+    metrics.source_stopped();
+    controller.stop();
+    auto measured = false;
+    for ( unsigned int slots = 1; slots <= tuner.max_slots(); ++slots ) { measured |= tuner.throughput( slots ) > 0; }
+    REQUIRE( measured );
+  }
+}
@@ -0,0 +1,85 @@
+#include "mockup/trace_writer.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace mockup;
+
+namespace {
+  std::size_t count_occurrences( const std::string& text, const std::string& pattern ) {
+    auto count = std::size_t{ 0 };
+    for ( auto pos = text.find( pattern ); pos != std::string::npos; pos = text.find( pattern, pos + 1 ) ) { ++count; }
+    return count;
+  }
+} // namespace
+
+TEST_CASE( "TraceWriter", "[trace]" ) {
+  const auto filename           = ( std::filesystem::temp_directory_path() / "mockup_trace_writer.test.bin" ).string();
+  const auto threads            = 4;
+  const auto records_per_thread = 1000;
+  {
+    // enough buffers for the whole run, so that nothing is dropped
+    auto writer = TraceWriter( filename, threads, 64, threads * records_per_thread / 64 + threads );
+    auto ids    = std::vector<std::uint32_t>{ writer.name_id( "Alg\"A" ), writer.name_id( "AlgB" ) };
+    REQUIRE( writer.name_id( "AlgB" ) == ids[1] );
+    auto workers = std::vector<std::thread>{};
+    for ( auto t = 0; t < threads; ++t ) {
+      workers.emplace_back( [&writer, &ids, t]() {
+        for ( auto i = 0; i < records_per_thread; ++i ) {
+          const auto begin = writer.now();
+          writer.record( t, ids[i % 2], begin, begin + 1500 );
+        }
+      } );
+    }
+    for ( auto& worker : workers ) { worker.join(); }
+    writer.close();
+    REQUIRE( writer.dropped() == 0 );
+  }
+
+  auto input  = std::ifstream( filename, std::ios::binary );
+  auto output = std::stringstream{};
+  convert_trace_to_chrome( input, output );
+  const auto json = output.str();
+  REQUIRE( json.rfind( "{\"traceEvents\":[", 0 ) == 0 );
+  REQUIRE( count_occurrences( json, "\"ph\":\"X\"" ) == threads * records_per_thread );
+  REQUIRE( count_occurrences( json, "\"name\":\"Alg\\\"A\"" ) == threads * records_per_thread / 2 );
+  REQUIRE( count_occurrences( json, "\"dur\":1.500" ) == threads * records_per_thread );
+  std::filesystem::remove( filename );
+}
+
+TEST_CASE( "TraceWriter bounded buffers", "[trace]" ) {
+  const auto filename = ( std::filesystem::temp_directory_path() / "mockup_trace_writer.bounded.bin" ).string();
+
+  const auto threads            = 4;
+  const auto records_per_thread = 10000;
+  auto       dropped            = std::uint64_t{ 0 };
+  {
+    // single-record buffers with one spare buffer make the writer fall behind the producers
+    auto writer  = TraceWriter( filename, threads, 1, threads + 1 );
+    auto id      = writer.name_id( "Alg" );
+    auto workers = std::vector<std::thread>{};
+    for ( auto t = 0; t < threads; ++t ) {
+      workers.emplace_back( [&writer, id, t]() {
+        for ( auto i = 0; i < records_per_thread; ++i ) { writer.record( t, id, 0, 1000 ); }
+      } );
+    }
+    for ( auto& worker : workers ) { worker.join(); }
+    writer.close();
+    dropped = writer.dropped();
+  }
+
+  auto input  = std::ifstream( filename, std::ios::binary );
+  auto output = std::stringstream{};
+  convert_trace_to_chrome( input, output );
+  REQUIRE( count_occurrences( output.str(), "\"ph\":\"X\"" ) + dropped == threads * records_per_thread );
+  std::filesystem::remove( filename );
+}
+
+TEST_CASE( "Convert foreign trace", "[trace]" ) {
+  auto input  = std::stringstream( "not a trace" );
+  auto output = std::stringstream{};
+  REQUIRE_THROWS( convert_trace_to_chrome( input, output ) );
+}